@@ -0,0 +1,429 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: bench.cpp
+ * Benchmarks for the emulation core. Each synthetic micro-ROM loops over
+ * one family of opcodes; ROM files given on the command line are run as
+ * real-game traces. Results are printed as one JSON object per line.
+ *
+ * Usage: chip8_bench [--cycles N] [--repeat N] [--out FILE] [rom...]
+ *
+ * No game ROMs ship with the repo, so traces only run for ROMs passed in.
+ * They are driven by a fixed, scripted key sequence rather than a recorded
+ * session. Runs that mostly sit on one instruction (FX0A waiting for a key,
+ * or a jump-to-self) are flagged "stalled" because they only measure a busy
+ * loop.
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "bench_revision.h"     //Generated by the build
+
+//Stamped in by the build so results can be compared across commits and compilers
+#ifndef CHIP8_BENCH_REVISION
+#define CHIP8_BENCH_REVISION "unknown"
+#endif
+#ifndef CHIP8_BENCH_COMPILER
+#define CHIP8_BENCH_COMPILER __VERSION__
+#endif
+
+//Counts every heap allocation so the report can show the core makes none.
+static std::atomic<unsigned long> allocations(0);
+static std::atomic<unsigned long> allocated_bytes(0);
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    allocated_bytes += size;
+    void *p = malloc(size ? size : 1);
+    if(p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+struct MicroRom {
+    const char *name;
+    std::vector<unsigned char> code;
+};
+
+//Synthetic programs. Each runs forever, stays inside the screen and memory,
+//and avoids FX18 so the sound timer never prints.
+static std::vector<MicroRom> microRoms()
+{
+    std::vector<MicroRom> roms;
+
+    //8XYN: every ALU operation in a loop
+    roms.push_back({ "alu_8xyn", {
+        0x60, 0x01,     //200: V0 = 1
+        0x61, 0x03,     //202: V1 = 3
+        0x80, 0x14,     //204: V0 += V1
+        0x80, 0x15,     //206: V0 -= V1
+        0x80, 0x11,     //208: V0 |= V1
+        0x80, 0x12,     //20A: V0 &= V1
+        0x80, 0x13,     //20C: V0 ^= V1
+        0x80, 0x16,     //20E: V0 >>= 1
+        0x80, 0x1E,     //210: V0 <<= 1
+        0x80, 0x17,     //212: V0 = V1 - V0
+        0x80, 0x10,     //214: V0 = V1
+        0x71, 0x01,     //216: V1 += 1
+        0x12, 0x04,     //218: jump 204
+    } });
+
+    //Skips, calls and jumps
+    roms.push_back({ "branch", {
+        0x70, 0x01,     //200: V0 += 1
+        0x30, 0x00,     //202: skip if V0 == 0
+        0x40, 0x00,     //204: skip if V0 != 0
+        0x90, 0x10,     //206: skip if V0 != V1
+        0x50, 0x10,     //208: skip if V0 == V1
+        0x22, 0x10,     //20A: call 210
+        0x12, 0x00,     //20C: jump 200
+        0x00, 0x00,     //20E: unused
+        0x00, 0xEE,     //210: return
+    } });
+
+    //DXYN: 15 row sprites drawn all over the screen
+    roms.push_back({ "draw_dxyn", {
+        0xA0, 0x00,     //200: I = font 0
+        0x62, 0x1F,     //202: V2 = 31
+        0x63, 0x0F,     //204: V3 = 15
+        0xD0, 0x1F,     //206: draw 15 rows at V0, V1
+        0x70, 0x03,     //208: V0 += 3
+        0x71, 0x05,     //20A: V1 += 5
+        0x80, 0x22,     //20C: V0 &= V2, keeps X below 32
+        0x81, 0x32,     //20E: V1 &= V3, keeps Y below 16
+        0xD0, 0x1F,     //210: draw again
+        0x12, 0x06,     //212: jump 206
+    } });
+
+    //FX55/FX65: store and load all 16 registers
+    roms.push_back({ "memory_fx55_fx65", {
+        0xA3, 0x00,     //200: I = 300
+        0xFF, 0x55,     //202: store V0-VF
+        0xA3, 0x00,     //204: I = 300
+        0xFF, 0x65,     //206: load V0-VF
+        0x70, 0x01,     //208: V0 += 1
+        0x12, 0x00,     //20A: jump 200
+    } });
+
+    //FX33: binary coded decimal
+    roms.push_back({ "bcd_fx33", {
+        0xA3, 0x00,     //200: I = 300
+        0xF0, 0x33,     //202: BCD of V0
+        0x70, 0x07,     //204: V0 += 7
+        0x12, 0x00,     //206: jump 200
+    } });
+
+    return roms;
+}
+
+//A frame is one 60 Hz tick at 600 instructions per second, a common chip-8
+//speed, so ns_per_frame exists for every program whether it draws or not.
+static const int CYCLES_PER_FRAME = 10;
+
+//Scripted input for traces: every KEY_PERIOD cycles a new key is held down.
+static const int KEY_PERIOD = 30;
+
+//Share of cycles that leave pc unchanged above which a run is flagged.
+static const double STALL_LIMIT = 0.5;
+
+struct Result {
+    double seconds;                 //Instruction pass
+    double frame_seconds;           //Frame pass
+    unsigned long draws;
+    unsigned long stalled_cycles;
+    unsigned long allocations;
+    unsigned long allocated_bytes;
+};
+
+//Fresh machine for one pass. Returns false if the ROM does not fit in memory.
+static bool setup(Chip8 &chip8, const std::vector<unsigned char> &rom)
+{
+    chip8.messages = NULL;  //Keep load, unknown opcode and beep messages out of the results.
+    if(!chip8.load(rom.data(), rom.size()))
+    {
+        return false;
+    }
+    chip8.seed(1);          //Same CXNN sequence every run.
+    chip8.draw_flag = false;  //Only count draws the program makes itself.
+    return true;
+}
+
+//Scripted input presses keys in a fixed pseudo-random order so games
+//waiting on FX0A or a key test keep moving.
+static void scriptKeys(Chip8 &chip8, long cycle, uint32_t &key_script)
+{
+    if(cycle % KEY_PERIOD == 0)
+    {
+        memset(chip8.key, 0, sizeof(chip8.key));
+        key_script = key_script * 1103515245 + 12345;
+        chip8.key[(key_script >> 16) & 0xF] = 1;
+    }
+}
+
+//Runs one ROM for a fixed number of cycles and times it twice. The
+//instruction pass runs cycles back to back. The frame pass runs the same
+//cycles in frames of CYCLES_PER_FRAME, and at the end of a frame that drew
+//copies the screen out, as the emulation loop hands it to the capture and
+//the front-end. Returns false if the ROM could not be loaded.
+static bool runOnce(const std::vector<unsigned char> &rom, long cycles, bool scripted_input, Result &result)
+{
+    result.draws = 0;
+    result.stalled_cycles = 0;
+    unsigned long allocs_before = allocations;
+    unsigned long bytes_before = allocated_bytes;
+
+    {
+        Chip8 chip8;
+        if(!setup(chip8, rom))
+        {
+            return false;
+        }
+        uint32_t key_script = 12345;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(long i = 0; i < cycles; i++)
+        {
+            if(scripted_input)
+            {
+                scriptKeys(chip8, i, key_script);
+            }
+
+            unsigned short pc = chip8.programCounter();
+            chip8.emulateCycle();
+            if(chip8.programCounter() == pc)
+            {
+                result.stalled_cycles++;
+            }
+
+            if(chip8.draw_flag)
+            {
+                chip8.draw_flag = false;
+                result.draws++;
+            }
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        result.seconds = std::chrono::duration<double>(end - start).count();
+    }
+
+    {
+        Chip8 chip8;
+        if(!setup(chip8, rom))
+        {
+            return false;
+        }
+        uint32_t key_script = 12345;
+        static unsigned char presented[64 * 32];
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(long i = 0; i < cycles; )
+        {
+            for(int c = 0; c < CYCLES_PER_FRAME && i < cycles; c++, i++)
+            {
+                if(scripted_input)
+                {
+                    scriptKeys(chip8, i, key_script);
+                }
+                chip8.emulateCycle();
+            }
+
+            if(chip8.draw_flag)
+            {
+                chip8.draw_flag = false;
+                memcpy(presented, chip8.gfx, sizeof(presented));
+            }
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        result.frame_seconds = std::chrono::duration<double>(end - start).count();
+    }
+
+    result.allocations = allocations - allocs_before;
+    result.allocated_bytes = allocated_bytes - bytes_before;
+    return true;
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+//Quotes a string for JSON, escaping quotes, backslashes and control characters.
+static std::string jsonString(const char *text)
+{
+    std::string quoted = "\"";
+    for(const char *c = text; *c; c++)
+    {
+        if(*c == '"' || *c == '\\')
+        {
+            quoted += '\\';
+            quoted += *c;
+        }
+        else if((unsigned char)*c < 0x20)
+        {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)*c);
+            quoted += escape;
+        }
+        else
+        {
+            quoted += *c;
+        }
+    }
+    return quoted + "\"";
+}
+
+//Runs one benchmark and prints its JSON line. Returns false if the ROM could not be loaded.
+static bool report(FILE *out, const char *kind, const char *name, const std::vector<unsigned char> &rom, long cycles, int repeat)
+{
+    bool trace = (strcmp(kind, "trace") == 0);
+
+    std::vector<Result> runs;
+    for(int r = 0; r < repeat; r++)
+    {
+        Result result;
+        if(!runOnce(rom, cycles, trace, result))
+        {
+            return false;
+        }
+        runs.push_back(result);
+    }
+
+    std::vector<double> times;
+    std::vector<double> frame_times;
+    for(size_t r = 0; r < runs.size(); r++)
+    {
+        times.push_back(runs[r].seconds);
+        frame_times.push_back(runs[r].frame_seconds);
+    }
+    double best = *std::min_element(times.begin(), times.end());
+    double median_s = median(times);
+    long frames = (cycles + CYCLES_PER_FRAME - 1) / CYCLES_PER_FRAME;
+
+    const Result &last = runs.back();
+    double stall_fraction = (double)last.stalled_cycles / cycles;
+
+    fprintf(out, "{\"benchmark\":%s,\"kind\":\"%s\",\"revision\":%s,\"compiler\":%s,"
+           "\"cycles\":%ld,\"repeat\":%d,\"best_s\":%.6f,\"median_s\":%.6f,"
+           "\"instructions_per_sec\":%.0f,\"ns_per_instruction\":%.3f,"
+           "\"cycles_per_frame\":%d,\"ns_per_frame\":%.1f,\"draws\":%lu,"
+           "\"stall_fraction\":%.4f,\"stalled\":%s,"
+           "\"allocations\":%lu,\"allocated_bytes\":%lu}\n",
+           jsonString(name).c_str(), kind,
+           jsonString(CHIP8_BENCH_REVISION).c_str(), jsonString(CHIP8_BENCH_COMPILER).c_str(),
+           cycles, repeat, best, median_s,
+           cycles / median_s, median_s * 1e9 / cycles,
+           CYCLES_PER_FRAME, median(frame_times) * 1e9 / frames, last.draws,
+           stall_fraction, stall_fraction > STALL_LIMIT ? "true" : "false",
+           last.allocations, last.allocated_bytes);
+    fflush(out);
+    return true;
+}
+
+static bool readFile(const char *path, std::vector<unsigned char> &data)
+{
+    FILE *file = fopen(path, "rb");
+    if(file == NULL)
+    {
+        return false;
+    }
+    unsigned char buffer[4096];
+    size_t n;
+    while((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    long cycles = 10000000;
+    int repeat = 5;
+    const char *out_path = NULL;
+    std::vector<const char *> traces;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--cycles") == 0 && i + 1 < argc)
+        {
+            cycles = atol(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeat = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            out_path = argv[++i];
+        }
+        else
+        {
+            traces.push_back(argv[i]);
+        }
+    }
+    if(cycles < 1 || repeat < 1)
+    {
+        fprintf(stderr, "Usage: %s [--cycles N] [--repeat N] [--out FILE] [rom...]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if(out_path != NULL && (out = fopen(out_path, "w")) == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", out_path);
+        return 1;
+    }
+
+    std::vector<MicroRom> roms = microRoms();
+    for(size_t i = 0; i < roms.size(); i++)
+    {
+        if(!report(out, "micro", roms[i].name, roms[i].code, cycles, repeat))
+        {
+            fprintf(stderr, "Could not load micro-ROM: %s\n", roms[i].name);
+            return 1;
+        }
+    }
+
+    //Real games, driven by the key script
+    for(size_t i = 0; i < traces.size(); i++)
+    {
+        std::vector<unsigned char> rom;
+        if(!readFile(traces[i], rom))
+        {
+            fprintf(stderr, "Could not open ROM: %s\n", traces[i]);
+            return 1;
+        }
+        if(!report(out, "trace", traces[i], rom, cycles, repeat))
+        {
+            fprintf(stderr, "ROM does not fit in chip-8 memory: %s\n", traces[i]);
+            return 1;
+        }
+    }
+
+    if(out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+# Writes the current git revision to OUTPUT as a C header. Run at build time
+# (see CMakeLists.txt) and only touches the file when the revision changes,
+# so unchanged builds do not recompile the benchmarks.
+execute_process(
+    COMMAND git rev-parse --short HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE CHIP8_REVISION
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET
+)
+if(NOT CHIP8_REVISION)
+    set(CHIP8_REVISION unknown)
+endif()
+
+set(CONTENT "#define CHIP8_BENCH_REVISION \"${CHIP8_REVISION}\"\n")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} OLD_CONTENT)
+endif()
+if(NOT "${CONTENT}" STREQUAL "${OLD_CONTENT}")
+    file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
@@ -0,0 +1,237 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: capture.cpp
+ * Records presented frames to disk. The emulator copies each frame into a
+ * ring buffer and returns straight away; a worker thread does the encoding
+ * and file writes so slow disks or pipes can never stall emulation.
+****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <chrono>
+
+#include "capture.h"
+
+FrameCapture::FrameCapture()
+    : out(NULL), is_pipe(false), head(0), tail(0), running(false),
+      frame_number(0), dropped(0), written(0), failed(false), since_keyframe(0),
+      messages(stderr)
+{
+
+}
+FrameCapture::~FrameCapture()
+{
+    close();
+}
+
+//Opens the output and starts the worker thread.
+bool FrameCapture::open(const char *path)
+{
+    if(worker.joinable())
+    {
+        close();
+    }
+
+    //A leading '|' pipes the stream into a command, e.g. "|gzip > run.c8rl.gz"
+    is_pipe = (path[0] == '|');
+    out = is_pipe ? popen(path + 1, "w") : fopen(path, "wb");
+    if(out == NULL)
+    {
+        printf("Could not open capture output: %s\n", path);
+        return false;
+    }
+
+    head = 0;
+    tail = 0;
+    frame_number = 0;
+    dropped = 0;
+    written = 0;
+    failed = false;
+    since_keyframe = 0;
+    memset(previous, 0, sizeof(previous));
+
+    running = true;
+    worker = std::thread(&FrameCapture::run, this);
+    return true;
+}
+
+//Stops the worker once every queued frame is written. The worker closes the output.
+void FrameCapture::close()
+{
+    if(!worker.joinable())
+    {
+        return;
+    }
+
+    running = false;
+    wake.notify_one();
+    worker.join();
+
+    printf("Capture: %u frames written, %u dropped%s\n", (unsigned)written, (unsigned)dropped,
+           failed ? " (output failed)" : "");
+}
+
+//Called from the emulation thread for each presented frame.
+void FrameCapture::submit(const unsigned char *gfx)
+{
+    if(!running)
+    {
+        return;
+    }
+
+    uint32_t number = frame_number++;
+
+    //Output failed: nothing more will be written
+    if(failed)
+    {
+        ++dropped;
+        return;
+    }
+
+    unsigned int h = head.load(std::memory_order_relaxed);
+    unsigned int t = tail.load(std::memory_order_acquire);
+
+    //Queue full: the worker is behind, so drop rather than wait on it.
+    if(h - t >= QUEUE_SIZE)
+    {
+        ++dropped;
+        return;
+    }
+
+    memcpy(queue[h % QUEUE_SIZE], gfx, FRAME_SIZE);
+    queue_frame[h % QUEUE_SIZE] = number;
+    head.store(h + 1, std::memory_order_release);
+    wake.notify_one();
+}
+
+uint32_t FrameCapture::droppedFrames() const
+{
+    return dropped;
+}
+
+uint32_t FrameCapture::writtenFrames() const
+{
+    return written;
+}
+
+//Worker thread: drains the queue until close() is called and it is empty.
+//Every write and the final close happen here, so a slow or broken output
+//only ever affects this thread.
+void FrameCapture::run()
+{
+    //A pipe reader that exits must not kill the emulator. With SIGPIPE blocked
+    //on this thread the write fails with EPIPE instead.
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, NULL);
+
+    unsigned char header[8] = { 'C', '8', 'R', 'L', 1, 64, 32, 0 };
+    if(fwrite(header, 1, sizeof(header), out) != sizeof(header))
+    {
+        fail();
+    }
+
+    while(true)
+    {
+        unsigned int t = tail.load(std::memory_order_relaxed);
+        if(t == head.load(std::memory_order_acquire))
+        {
+            if(!running)
+            {
+                break;
+            }
+            //Timeout covers a notify that lands before we start waiting.
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+
+        if(failed)
+        {
+            ++dropped;
+        }
+        else if(encode(queue[t % QUEUE_SIZE], queue_frame[t % QUEUE_SIZE]))
+        {
+            ++written;
+        }
+        else
+        {
+            ++dropped;
+            fail();
+        }
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    if(is_pipe)
+    {
+        pclose(out);
+    }
+    else
+    {
+        fclose(out);
+    }
+    out = NULL;
+}
+
+//Stops writing after an error such as a full disk or a closed pipe.
+//Later frames are counted as dropped.
+void FrameCapture::fail()
+{
+    if(!failed)
+    {
+        failed = true;
+        if(messages != NULL)
+        {
+            fprintf(messages, "Capture: write failed, stopping capture\n");
+        }
+    }
+}
+
+//Delta and run-length encodes a frame and writes it as one record.
+//Returns false if the record could not be written.
+bool FrameCapture::encode(const unsigned char *frame, uint32_t number)
+{
+    bool keyframe = (since_keyframe == 0);
+    int size = 0;
+
+    int i = 0;
+    while(i < FRAME_SIZE)
+    {
+        unsigned char value = keyframe ? frame[i] : (frame[i] ^ previous[i]);
+        int count = 1;
+        while(i + count < FRAME_SIZE && count < 255)
+        {
+            unsigned char next = keyframe ? frame[i + count] : (frame[i + count] ^ previous[i + count]);
+            if(next != value)
+            {
+                break;
+            }
+            count++;
+        }
+        encoded[size++] = (unsigned char)count;
+        encoded[size++] = value;
+        i += count;
+    }
+
+    unsigned char record[7] = {
+        (unsigned char)(number), (unsigned char)(number >> 8),
+        (unsigned char)(number >> 16), (unsigned char)(number >> 24),
+        (unsigned char)(keyframe ? 0 : 1),
+        (unsigned char)(size), (unsigned char)(size >> 8)
+    };
+    //Flushed per record so a failing output is noticed straight away
+    if(fwrite(record, 1, sizeof(record), out) != sizeof(record) ||
+       fwrite(encoded, 1, size, out) != (size_t)size ||
+       fflush(out) != 0)
+    {
+        return false;
+    }
+
+    memcpy(previous, frame, FRAME_SIZE);
+    since_keyframe = (since_keyframe + 1) % KEYFRAME_INTERVAL;
+    return true;
+}
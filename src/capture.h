@@ -0,0 +1,80 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: capture.h
+ * Header file for the frame capture class. Frames are handed off to a
+ * worker thread which delta and run-length encodes them into a file or pipe.
+****************************************************************************/
+#ifndef CAPTURE_H
+#define CAPTURE_H
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*Capture stream layout (all integers little endian):
+    header: "C8RL", uint8 version, uint8 width, uint8 height, uint8 reserved
+    record: uint32 frame number, uint8 type (0 = key frame, 1 = delta),
+            uint16 payload size, payload
+    payload: (count, value) byte pairs, count 1-255. Key frames encode the
+            pixels themselves, delta frames encode pixels XOR previous record.
+    Gaps in the frame numbers are frames that were dropped. tools/c8rl.cpp
+    reads this format back.
+*/
+class FrameCapture {
+    private:
+
+        static const int FRAME_SIZE = 64 * 32;
+        static const int QUEUE_SIZE = 64;       //Frames buffered between emulator and worker.
+        static const int KEYFRAME_INTERVAL = 60;
+
+        FILE* out;
+        bool is_pipe;
+
+        //Single producer / single consumer ring of frames.
+        unsigned char queue[QUEUE_SIZE][FRAME_SIZE];
+        uint32_t queue_frame[QUEUE_SIZE];
+        std::atomic<unsigned int> head;         //Next slot the emulator writes.
+        std::atomic<unsigned int> tail;         //Next slot the worker reads.
+
+        std::atomic<bool> running;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::thread worker;
+
+        uint32_t frame_number;                  //Frames offered, including dropped ones.
+        std::atomic<uint32_t> dropped;
+        std::atomic<uint32_t> written;
+        std::atomic<bool> failed;               //Output hit an error, the rest is dropped.
+
+        //Worker state
+        unsigned char previous[FRAME_SIZE];
+        unsigned char encoded[FRAME_SIZE * 2];
+        int since_keyframe;
+
+        void run();
+        bool encode(const unsigned char * frame, uint32_t number);
+        void fail();
+
+
+    public:
+
+        FrameCapture();
+        ~FrameCapture();
+
+        FILE *messages;                         //Where errors during the run go. stderr by default,
+                                                //NULL silences them. Set before open().
+
+        bool open(const char * path);           //File path, or "|command" to pipe frames to a process.
+        void close();                           //Flushes queued frames and reports drops.
+
+        void submit(const unsigned char * gfx); //Never blocks. Drops the frame if the queue is full.
+
+        uint32_t droppedFrames() const;
+        uint32_t writtenFrames() const;
+};
+
+#endif /* CAPTURE_H  */
@@ -9,6 +9,7 @@
 ****************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <iostream>
 #include <time.h>
 
@@ -37,7 +38,7 @@ unsigned char chip8_fontset[80] =
 
 Chip8::Chip8()
 {
-
+    messages = stdout;
 }
 Chip8::~Chip8()
 {
@@ -84,8 +85,45 @@ void Chip8::init()
 
     draw_flag = true;
 
-    //Initialize random seed for 0xC000
-    srand(time(NULL));
+    //Initialize random seed for 0xC000. Each instance has its own generator so
+    //several can run on different threads; the address keeps their seeds apart.
+    seed((uint32_t)time(NULL) ^ (uint32_t)(uintptr_t)this);
+}
+
+
+//Seeds the generator used by CXNN. Same seed gives the same sequence.
+void Chip8::seed(uint32_t value)
+{
+    rand_state = value ? value : 1;     //xorshift needs a non-zero state
+}
+
+unsigned short Chip8::programCounter() const
+{
+    return pc;
+}
+
+//xorshift32 random number generator, private to this instance.
+uint32_t Chip8::nextRandom()
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+
+//Prints a runtime diagnostic (unknown opcode, beep) to messages, if set.
+void Chip8::message(const char *format, ...)
+{
+    if(messages == NULL)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(messages, format, args);
+    va_end(args);
 }
 
 
@@ -95,12 +133,12 @@ bool Chip8::load(const char *file_path)
     //Initialise
     init();
 
-    printf("Loading ROM: %s\n", file_path);
+    message("Loading ROM: %s\n", file_path);
 
     //Open ROM file with file poitners
     FILE* rom = fopen(file_path, "rb");
     if (rom == NULL) {
-        printf("Could not open ROM.");
+        message("Could not open ROM.\n");
         return false;
     }
 
@@ -113,33 +151,49 @@ bool Chip8::load(const char *file_path)
     //Dynamically allocate memory to store the rom. 
     char* buffer = (char*) malloc(sizeof(char) * rom_size);
     if (buffer == NULL) {
-        printf("Could not allocate memory");
+        message("Could not allocate memory\n");
         return false;
     }
 
     //Copy ROM into buffer
     size_t result = fread(buffer, sizeof(char), (size_t)rom_size, rom);
     if (result != rom_size) {
-        printf("ERROR");
+        message("ERROR\n");
         return false;
     }
 
-    //Copy rom into the Chip8 memory, starting at 0x200, or 512
+    //Close the rom file
+    fclose(rom);
+
+    //Copy rom into the Chip8 memory, then free the buffer.
+    bool loaded = copyRom((const unsigned char *)buffer, rom_size);
+    free(buffer);
+
+    return loaded;
+}
+
+//Loads a rom that is already in memory, e.g. a generated test program.
+bool Chip8::load(const unsigned char *rom, size_t rom_size)
+{
+    //Initialise
+    init();
+
+    return copyRom(rom, rom_size);
+}
+
+//Copy rom into the Chip8 memory, starting at 0x200, or 512
+bool Chip8::copyRom(const unsigned char *rom, size_t rom_size)
+{
     if ((4096-512) > rom_size){
-        for (int i = 0; i < rom_size; i++) {
-            memory[i + 512] = (uint8_t)buffer[i];    
+        for (size_t i = 0; i < rom_size; i++) {
+            memory[i + 512] = (uint8_t)rom[i];    
         }
     }
     else {
-        printf("ROM too large to fit in memory.");
+        message("ROM too large to fit in memory.\n");
         return false;
     }
 
-    //Close the rom file and free the buffer. 
-    fclose(rom);
-    free(buffer);
-
-
     return true;
 }
 
@@ -178,7 +232,7 @@ void Chip8::emulateCycle()
                     break;
 
                 default: 
-                    printf("Opcode not found: 0x%X\n", opcode);
+                    message("Opcode not found: 0x%X\n", opcode);
             }
             break;
         
@@ -315,7 +369,7 @@ void Chip8::emulateCycle()
                     break;
 
                 default:
-                    printf("Opcode not found: 0x%X\n", opcode);
+                    message("Opcode not found: 0x%X\n", opcode);
                     break;
             }
             break;
@@ -344,7 +398,7 @@ void Chip8::emulateCycle()
         {
             //CXNN: Sets VX to the result of bitwise op on a random number (0-255) and NN
         
-            int rand_n = rand() % 256;                                    //Generates a random number between 0-255 using the random seed.
+            int rand_n = nextRandom() % 256;                              //Generates a random number between 0-255 using the random seed.
             V[(opcode & 0x0F00) >> 8] = rand_n & ((opcode & 0x00FF));     //Sets VX to bitwise op on rand and NN
 
             pc += 2;         
@@ -416,7 +470,7 @@ void Chip8::emulateCycle()
                     break;
 
                 default:
-                    printf("Opcode not found: 0x%X\n", opcode);
+                    message("Opcode not found: 0x%X\n", opcode);
             }
 
         case 0xF000: 
@@ -509,13 +563,13 @@ void Chip8::emulateCycle()
                     break;
 
                 default:
-                    printf("Opcode not found: 0x%X\n", opcode);
+                    message("Opcode not found: 0x%X\n", opcode);
                     break;
             }
             break;
         
         default: 
-            printf("Opcode not found: 0x%X\n", opcode);
+            message("Opcode not found: 0x%X\n", opcode);
             break;
     }
 
@@ -528,7 +582,7 @@ void Chip8::emulateCycle()
     {
         if(sound_timer == 1)
         {
-            printf("Beep - sound not yet implemented\n");
+            message("Beep - sound not yet implemented\n");
         }
         --sound_timer;
     }
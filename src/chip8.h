@@ -8,6 +8,8 @@
 #ifndef CHIP_8_H
 #define CHIP_8_H
 #include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
 
 class Chip8 {
     private:
@@ -27,7 +29,14 @@ class Chip8 {
         unsigned short stack[16];           
         unsigned short sp;                  //Stack pointer
 
+        uint32_t rand_state;                //Random number generator state for CXNN
+
         void init();    
+        bool copyRom(const unsigned char * rom, size_t rom_size);
+        uint32_t nextRandom();
+        void message(const char * format, ...);
+
+        friend class GdbStub;               //Debugger reads and writes registers directly.
     
     
     public: 
@@ -36,12 +45,17 @@ class Chip8 {
         ~Chip8();
         
         void emulateCycle();                //Function to emulate a single chip-8 cpu cycle.
+        void seed(uint32_t value);          //Seed CXNN's random numbers, e.g. for repeatable runs
+        unsigned short programCounter() const;
         bool load(const char * filename);   //Load ROM
+        bool load(const unsigned char * rom, size_t rom_size);  //Load ROM already in memory
 
         unsigned char gfx[64 *32];          //represents 2048 pixel screen.
 
         unsigned char key[16];     
 
+        FILE *messages;                     //Where load and runtime diagnostics go. stdout by default, NULL silences them.
+
         bool draw_flag;                     //System sets a drawflag to indicate that we need to update screen.
                                             //Only 2 opcodes update screen: 0x00E0(clear screen), and 0xDXYN(draw sprite)
 
@@ -0,0 +1,21 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: frontend.h
+ * Interface between the emulation loop and whatever shows the screen and
+ * reads the keys (SDL window or terminal).
+****************************************************************************/
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+class Frontend {
+    public:
+
+        virtual ~Frontend() {}
+
+        virtual bool pollInput(unsigned char * key) = 0;    //Updates the 16 chip-8 keys. Returns false to quit.
+        virtual void present(const unsigned char * gfx) = 0;//Shows a 64x32 frame.
+};
+
+#endif /* FRONTEND_H  */
@@ -0,0 +1,613 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: gdbstub.cpp
+ * Minimal GDB remote serial protocol server. The main loop only calls into
+ * the stub when --gdb is given, and breakpoints are a bitmap lookup on pc,
+ * so normal runs pay nothing for it.
+ * Protocol reference: https://sourceware.org/gdb/current/onlinedocs/gdb.html/Remote-Protocol.html
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "gdbstub.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static int hexValue(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+//Size in bytes of register n, see the table in gdbstub.h
+static int registerSize(int n)
+{
+    return (n < 16 || n == 35 || n == 36) ? 1 : 2;
+}
+
+static void appendHexByte(std::string &out, unsigned char value)
+{
+    out += hex_digits[value >> 4];
+    out += hex_digits[value & 0xF];
+}
+
+//Parses a little endian hex value of len bytes, as gdb sends register contents.
+static bool parseHexLE(const char *hex, int len, unsigned int &value)
+{
+    value = 0;
+    for(int i = 0; i < len; i++)
+    {
+        int hi = hexValue(hex[i * 2]);
+        int lo = hexValue(hex[i * 2 + 1]);
+        if(hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        value |= (unsigned int)((hi << 4) | lo) << (8 * i);
+    }
+    return true;
+}
+
+GdbStub::GdbStub(Chip8 &chip8)
+    : chip8(chip8), listen_fd(-1), client_fd(-1), watch_count(0),
+      halted(true), stepping(false), step_over(false), killed(false),
+      poll_counter(0), watch_hit(-1), old_I(0), messages(stdout)
+{
+    memset(breakpoints, 0, sizeof(breakpoints));
+    memset(watchpoints, 0, sizeof(watchpoints));
+}
+GdbStub::~GdbStub()
+{
+    disconnect();
+    if(listen_fd >= 0)
+    {
+        close(listen_fd);
+    }
+}
+
+//Opens a localhost-only socket and blocks until gdb connects.
+bool GdbStub::listen(int port)
+{
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(listen_fd < 0)
+    {
+        printf("Could not create debugger socket.\n");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) < 0 || ::listen(listen_fd, 1) < 0)
+    {
+        printf("Could not listen for debugger on port %d.\n", port);
+        return false;
+    }
+
+    printf("Waiting for debugger on localhost:%d\n", port);
+    client_fd = accept(listen_fd, NULL, NULL);
+    if(client_fd < 0)
+    {
+        printf("Debugger connection failed.\n");
+        return false;
+    }
+
+    int nodelay = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    printf("Debugger connected.\n");
+
+    //Stay halted at the entry point until told to run.
+    halted = true;
+    return true;
+}
+
+//Called before every cycle. Checks breakpoints and runs the command loop while halted.
+bool GdbStub::beforeCycle()
+{
+    if(client_fd < 0)
+    {
+        return !killed;
+    }
+
+    //Look for a Ctrl-C from gdb without making a syscall every cycle.
+    if((++poll_counter & 0xFF) == 0)
+    {
+        char c;
+        ssize_t got = recv(client_fd, &c, 1, MSG_DONTWAIT);
+        if(got == 0)
+        {
+            //gdb went away while the program was running
+            disconnect();
+            return !killed;
+        }
+        if(got == 1 && c == 0x03)
+        {
+            stop("S02");
+        }
+    }
+
+    if(halted)
+    {
+        halted = false;
+        commandLoop();
+    }
+    else if(!step_over && (breakpoints[(chip8.pc & 0xFFF) >> 3] & (1 << (chip8.pc & 7))))
+    {
+        stop("S05");
+    }
+    step_over = false;
+
+    if(killed || client_fd < 0)
+    {
+        return !killed;
+    }
+
+    //Work out whether this cycle writes to a watched address. Only FX33 and FX55
+    //write memory, and both write at I. Writes to I are caught by comparing after.
+    watch_hit = -1;
+    old_I = chip8.I;
+    if(watch_count > 0)
+    {
+        unsigned short op = chip8.memory[chip8.pc & 0xFFF] << 8 | chip8.memory[(chip8.pc + 1) & 0xFFF];
+        unsigned int len = 0;
+        if((op & 0xF0FF) == 0xF033)
+        {
+            len = 3;
+        }
+        else if((op & 0xF0FF) == 0xF055)
+        {
+            len = ((op & 0x0F00) >> 8) + 1;
+        }
+        for(unsigned int i = 0; i < len; i++)
+        {
+            if(watched(chip8.I + i, 1))
+            {
+                watch_hit = chip8.I + i;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+//Called after every cycle. Reports watchpoint hits and completed single steps.
+void GdbStub::afterCycle()
+{
+    if(client_fd < 0)
+    {
+        return;
+    }
+
+    if(watch_hit < 0 && chip8.I != old_I && watched(0x1000, 2))
+    {
+        watch_hit = 0x1000;
+    }
+
+    if(watch_hit >= 0)
+    {
+        char reason[32];
+        snprintf(reason, sizeof(reason), "T05watch:%x;", watch_hit);
+        stepping = false;
+        stop(reason);
+    }
+    else if(stepping)
+    {
+        stepping = false;
+        stop("S05");
+    }
+}
+
+//Sends a stop reply and waits for the debugger to resume or detach.
+void GdbStub::stop(const std::string &reason)
+{
+    sendPacket(reason);
+    commandLoop();
+}
+
+void GdbStub::commandLoop()
+{
+    std::string packet;
+    while(client_fd >= 0 && readPacket(packet))
+    {
+        if(handlePacket(packet))
+        {
+            return;
+        }
+    }
+}
+
+//Handles one packet. Returns true when execution should continue.
+bool GdbStub::handlePacket(const std::string &packet)
+{
+    const char *args = packet.c_str() + 1;
+    std::string reply;
+
+    switch(packet.empty() ? 0 : packet[0])
+    {
+        case '?':       //Reason the target halted
+            sendPacket("S05");
+            return false;
+
+        case 'g':       //Read all registers
+            for(int n = 0; n < 37; n++)
+            {
+                readRegister(n, reply);
+            }
+            sendPacket(reply);
+            return false;
+
+        case 'G':       //Write all registers
+        {
+            const char *p = args;
+            for(int n = 0; n < 37 && *p; n++)
+            {
+                if(!writeRegister(n, p))
+                {
+                    sendPacket("E01");
+                    return false;
+                }
+                p += registerSize(n) * 2;
+            }
+            sendPacket("OK");
+            return false;
+        }
+
+        case 'p':       //Read one register
+        {
+            char *end;
+            int n = strtol(args, &end, 16);
+            if(end == args || *end != '\0' || n < 0 || n > 36)
+            {
+                sendPacket("E01");
+                return false;
+            }
+            readRegister(n, reply);
+            sendPacket(reply);
+            return false;
+        }
+
+        case 'P':       //Write one register: Pn=value
+        {
+            char *end;
+            int n = strtol(args, &end, 16);
+            sendPacket(end != args && *end == '=' && writeRegister(n, end + 1) ? "OK" : "E01");
+            return false;
+        }
+
+        case 'm':       //Read memory: maddr,len
+        {
+            char *end;
+            unsigned int addr = strtoul(args, &end, 16);
+            if(end == args || *end != ',')
+            {
+                sendPacket("E01");
+                return false;
+            }
+            unsigned int len = strtoul(end + 1, NULL, 16);
+            for(unsigned int i = 0; i < len; i++)
+            {
+                unsigned char value;
+                if(!readByte(addr + i, value))
+                {
+                    break;
+                }
+                appendHexByte(reply, value);
+            }
+            sendPacket(reply.empty() && len > 0 ? "E01" : reply);
+            return false;
+        }
+
+        case 'M':       //Write memory: Maddr,len:data
+        {
+            char *end;
+            unsigned int addr = strtoul(args, &end, 16);
+            bool ok = (end != args && *end == ',');
+            unsigned int len = ok ? strtoul(end + 1, &end, 16) : 0;
+            const char *data = ok ? strchr(end, ':') : NULL;
+            ok = (data != NULL && strlen(data + 1) >= len * 2);
+            for(unsigned int i = 0; ok && i < len; i++)
+            {
+                unsigned int value;
+                ok = parseHexLE(data + 1 + i * 2, 1, value) && writeByte(addr + i, value);
+            }
+            sendPacket(ok ? "OK" : "E01");
+            return false;
+        }
+
+        case 'c':       //Continue, optionally from a new address
+        case 's':       //Single step
+            if(*args)
+            {
+                char *end;
+                unsigned long addr = strtoul(args, &end, 16);
+                if(*end != '\0' || addr > MAX_PC)
+                {
+                    sendPacket("E01");
+                    return false;
+                }
+                chip8.pc = addr;
+            }
+            stepping = (packet[0] == 's');
+            step_over = true;
+            return true;
+
+        case 'Z':       //Insert breakpoint / watchpoint: Ztype,addr,kind
+        case 'z':       //Remove
+        {
+            bool insert = (packet[0] == 'Z');
+            char *end;
+            int type = strtol(args, &end, 16);
+            if(end == args || *end != ',')
+            {
+                sendPacket("E01");
+                return false;
+            }
+            const char *addr_start = end + 1;
+            unsigned int addr = strtoul(addr_start, &end, 16);
+            if(end == addr_start || *end != ',')
+            {
+                sendPacket("E01");
+                return false;
+            }
+            unsigned int len = strtoul(end + 1, NULL, 16);
+
+            if(type == 0 || type == 1)
+            {
+                if(addr >= 4096)
+                {
+                    sendPacket("E01");
+                    return false;
+                }
+                if(insert)
+                    breakpoints[addr >> 3] |= (1 << (addr & 7));
+                else
+                    breakpoints[addr >> 3] &= ~(1 << (addr & 7));
+                sendPacket("OK");
+            }
+            else if(type == 2)  //Write watchpoints only
+            {
+                if(addr + len > ADDRESS_SPACE)
+                {
+                    sendPacket("E01");
+                    return false;
+                }
+                //Overlapping watchpoints share addresses, so each address
+                //keeps a count of the watchpoints covering it.
+                for(unsigned int a = addr; a < addr + len; a++)
+                {
+                    if(insert)
+                    {
+                        if(watchpoints[a]++ == 0)
+                            watch_count++;
+                    }
+                    else if(watchpoints[a] > 0)
+                    {
+                        if(--watchpoints[a] == 0)
+                            watch_count--;
+                    }
+                }
+                sendPacket("OK");
+            }
+            else
+            {
+                sendPacket("");
+            }
+            return false;
+        }
+
+        case 'k':       //Kill
+            killed = true;
+            disconnect();
+            return true;
+
+        case 'D':       //Detach and let the program run freely
+            sendPacket("OK");
+            disconnect();
+            return true;
+
+        case 'H':       //Set thread, there is only one
+            sendPacket("OK");
+            return false;
+
+        case 'q':
+            if(packet.compare(0, 10, "qSupported") == 0)
+            {
+                sendPacket("PacketSize=400");
+            }
+            else if(packet == "qAttached")
+            {
+                sendPacket("1");
+            }
+            else if(packet == "qC")
+            {
+                sendPacket("QC1");
+            }
+            else
+            {
+                sendPacket("");
+            }
+            return false;
+
+        default:        //Unsupported packets get an empty reply
+            sendPacket("");
+            return false;
+    }
+}
+
+//Appends register n as little endian hex.
+void GdbStub::readRegister(int n, std::string &out)
+{
+    unsigned int value;
+
+    if(n < 16)       value = chip8.V[n];
+    else if(n == 16) value = chip8.I;
+    else if(n == 17) value = chip8.pc;
+    else if(n == 18) value = chip8.sp;
+    else if(n < 35)  value = chip8.stack[n - 19];
+    else if(n == 35) value = chip8.delay_timer;
+    else             value = chip8.sound_timer;
+
+    for(int i = 0; i < registerSize(n); i++)
+    {
+        appendHexByte(out, (value >> (8 * i)) & 0xFF);
+    }
+}
+
+bool GdbStub::writeRegister(int n, const char *hex)
+{
+    unsigned int value;
+    if(n < 0 || n > 36 || !parseHexLE(hex, registerSize(n), value))
+    {
+        return false;
+    }
+
+    //Addresses the core will index memory with must stay inside it
+    if((n == 16 && value > 0xFFF) || ((n == 17 || (n >= 19 && n < 35)) && value > MAX_PC))
+    {
+        return false;
+    }
+
+    if(n < 16)       chip8.V[n] = value;
+    else if(n == 16) chip8.I = value;
+    else if(n == 17) chip8.pc = value;
+    else if(n == 18) chip8.sp = value & 0xF;
+    else if(n < 35)  chip8.stack[n - 19] = value;
+    else if(n == 35) chip8.delay_timer = value;
+    else             chip8.sound_timer = value;
+    return true;
+}
+
+bool GdbStub::readByte(unsigned int addr, unsigned char &value)
+{
+    if(addr < 4096)
+        value = chip8.memory[addr];
+    else if(addr < ADDRESS_SPACE)
+        value = (chip8.I >> (8 * (addr - 0x1000))) & 0xFF;
+    else
+        return false;
+    return true;
+}
+
+bool GdbStub::writeByte(unsigned int addr, unsigned char value)
+{
+    if(addr < 4096)
+    {
+        chip8.memory[addr] = value;
+    }
+    else if(addr < ADDRESS_SPACE)
+    {
+        int shift = 8 * (addr - 0x1000);
+        unsigned int new_I = (chip8.I & ~(0xFF << shift)) | (value << shift);
+        if(new_I > 0xFFF)
+        {
+            return false;
+        }
+        chip8.I = new_I;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool GdbStub::watched(unsigned int addr, unsigned int len)
+{
+    for(unsigned int a = addr; a < addr + len && a < ADDRESS_SPACE; a++)
+    {
+        if(watchpoints[a] != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//Reads one $data#checksum packet, acknowledging it. Returns false if gdb went away.
+bool GdbStub::readPacket(std::string &packet)
+{
+    char c;
+    while(true)
+    {
+        //Skip acks and anything else until the start of a packet.
+        do
+        {
+            if(recv(client_fd, &c, 1, 0) != 1)
+            {
+                disconnect();
+                return false;
+            }
+        } while(c != '$');
+
+        packet.clear();
+        unsigned char sum = 0;
+        while(recv(client_fd, &c, 1, 0) == 1 && c != '#')
+        {
+            packet += c;
+            sum += (unsigned char)c;
+        }
+
+        char check[2];
+        if(c != '#' || recv(client_fd, check, 2, MSG_WAITALL) != 2)
+        {
+            disconnect();
+            return false;
+        }
+
+        if(hexValue(check[0]) * 16 + hexValue(check[1]) == sum)
+        {
+            send(client_fd, "+", 1, MSG_NOSIGNAL);
+            return true;
+        }
+        send(client_fd, "-", 1, MSG_NOSIGNAL);
+    }
+}
+
+void GdbStub::sendPacket(const std::string &data)
+{
+    if(client_fd < 0)
+    {
+        return;
+    }
+
+    unsigned char sum = 0;
+    for(size_t i = 0; i < data.size(); i++)
+    {
+        sum += (unsigned char)data[i];
+    }
+
+    std::string out = "$" + data + "#";
+    appendHexByte(out, sum);
+    //MSG_NOSIGNAL: a debugger that vanished must not SIGPIPE the emulator,
+    //the next recv notices it is gone instead.
+    send(client_fd, out.data(), out.size(), MSG_NOSIGNAL);
+}
+
+void GdbStub::disconnect()
+{
+    if(client_fd >= 0)
+    {
+        close(client_fd);
+        client_fd = -1;
+        if(messages != NULL)
+        {
+            fprintf(messages, "Debugger disconnected.\n");
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: gdbstub.h
+ * Header file for the GDB remote serial protocol debug stub.
+****************************************************************************/
+#ifndef GDB_STUB_H
+#define GDB_STUB_H
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include "chip8.h"
+
+/*Register numbers used by g/G/p/P packets:
+    0-15    V0-VF       (1 byte each)
+    16      I           (2 bytes, little endian)
+    17      pc          (2 bytes)
+    18      sp          (2 bytes)
+    19-34   stack[0-15] (2 bytes each)
+    35      delay timer (1 byte)
+    36      sound timer (1 byte)
+
+  Memory map for m/M packets and watchpoints:
+    0x0000-0x0FFF   chip-8 memory
+    0x1000-0x1001   I register, so "watch *(short *)0x1000" watches I
+
+  pc, I and stack entries only accept addresses inside chip-8 memory.
+  Stock gdb has no chip-8 architecture, so these registers are reached by
+  number with "maint packet p11" / "maint packet P11=0002" (see README).
+*/
+class GdbStub {
+    private:
+
+        static const unsigned int ADDRESS_SPACE = 0x1002;  //Memory plus the two bytes of I.
+        static const unsigned int MAX_PC = 0xFFE;           //Highest pc that can still fetch a whole opcode.
+
+        Chip8 &chip8;
+
+        int listen_fd;
+        int client_fd;
+
+        unsigned char breakpoints[4096 / 8];    //One bit per address, checked against pc.
+        unsigned short watchpoints[ADDRESS_SPACE];  //Number of watchpoints covering each address.
+        int watch_count;                        //Addresses with at least one watchpoint.
+
+        bool halted;                            //Waiting for a command from the debugger.
+        bool stepping;                          //Stop again after the next cycle.
+        bool step_over;                         //Skip the breakpoint check once after resuming.
+        bool killed;
+        unsigned int poll_counter;
+
+        //Write watch state captured before each cycle
+        int watch_hit;                          //Address that will be written, or -1.
+        unsigned short old_I;
+
+        void stop(const std::string &reason);
+        void commandLoop();
+        bool handlePacket(const std::string &packet);   //Returns true when execution should resume.
+
+        bool readPacket(std::string &packet);
+        void sendPacket(const std::string &data);
+        void disconnect();
+
+        void readRegister(int n, std::string &out);
+        bool writeRegister(int n, const char *hex);
+        bool readByte(unsigned int addr, unsigned char &value);
+        bool writeByte(unsigned int addr, unsigned char value);
+        bool watched(unsigned int addr, unsigned int len);
+
+
+    public:
+
+        GdbStub(Chip8 &chip8);
+        ~GdbStub();
+
+        FILE *messages;                     //Where notices during the run go. stdout by default, NULL silences them.
+
+        bool listen(int port);              //Waits on localhost:port until a debugger connects.
+
+        bool beforeCycle();                 //Returns false once the debugger has killed the program.
+        void afterCycle();
+};
+
+#endif /* GDB_STUB_H  */
@@ -3,173 +3,178 @@
  * Author: Peter Dorich
   
  * File: main.cpp
- * Main function that loads graphics support from SDL.
- * To learn the basics of SDL, I used the tutorial guides from LazyFoo.com
- * https://lazyfoo.net/tutorials/SDL/index.php#Key%20Presses
+ * Main function. Parses the command line, loads the ROM and hands it to
+ * the emulation loop with the chosen front-end.
 ****************************************************************************/
-#include <SDL2/SDL.h>
 #include <iostream>
-#include <thread>
+#include <vector>
 #include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
 #include "chip8.h"
+#include "capture.h"
+#include "gdbstub.h"
+#include "scheduler.h"
+#include "term.h"
+#ifdef CHIP8_SDL
+#include <SDL2/SDL.h>
+#include "sdl_frontend.h"
+#include "wall.h"
+#endif
 
 
 using namespace std;
 
-//keymap representing 16 keys from 1-v
-uint8_t keymap[16] = {
-    SDLK_1, SDLK_2, SDLK_3,
-    SDLK_q, SDLK_w, SDLK_e,
-    SDLK_a, SDLK_s, SDLK_d,
-    SDLK_z, SDLK_x, SDLK_c,
-    SDLK_4, SDLK_r, SDLK_f,
-    SDLK_v,
-};
-
 int main(int argc, char** args)
 {
 
 	//Initialize Chip8 emulator
 	Chip8 chip8;
 
-	//Screen size
-	int width = 64;
-	int height = 32;
-
-	//SDL window, renderer, and texture
-	SDL_Window* window = NULL;
-	SDL_Renderer *renderer = NULL;
-	SDL_Texture *texture = NULL;
-
-	//Create window. I wanted it bigger, so it is scaled up by 15
-	window = SDL_CreateWindow("CHIP-8 Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width *15, height*15, SDL_WINDOW_SHOWN);
-	if (window == NULL){
-        printf( "Error creating SDL window. SDL_Error: %s\n", SDL_GetError() );
-		return 1;
-    }
+	//Sticking with just loading PONG as a way to show off emulator.
+	const char *file_path = "roms/PONG";
+
+	//Command line: [rom...] [--headless] [--cycles N] [--capture FILE] [--gdb PORT] [--wall N] [--term]
+	bool headless = false;				//Run without a window, e.g. for regression runs
+	bool terminal = false;				//Draw in the terminal instead of a window
+	long max_cycles = -1;				//Stop after this many cycles, 0 or less runs until quit
+	const char *capture_path = NULL;	//Record presented frames to this file or "|command"
+	int gdb_port = 0;					//Wait for a gdb connection on this localhost port
+	int wall_count = 0;					//Show this many sessions in one window instead
+	vector<const char *> roms;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(args[i], "--headless") == 0)
+		{
+			headless = true;
+		}
+		else if(strcmp(args[i], "--term") == 0)
+		{
+			terminal = true;
+		}
+		else if(strcmp(args[i], "--cycles") == 0 && i + 1 < argc)
+		{
+			max_cycles = atol(args[++i]);
+		}
+		else if(strcmp(args[i], "--capture") == 0 && i + 1 < argc)
+		{
+			capture_path = args[++i];
+		}
+		else if(strcmp(args[i], "--gdb") == 0 && i + 1 < argc)
+		{
+			gdb_port = atoi(args[++i]);
+		}
+		else if(strcmp(args[i], "--wall") == 0 && i + 1 < argc)
+		{
+			wall_count = atoi(args[++i]);
+		}
+		else
+		{
+			roms.push_back(args[i]);
+		}
+	}
 
-	//Create renderer for window
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    SDL_RenderSetLogicalSize(renderer, width, height);
-	if(renderer == NULL)
+	if(roms.empty())
 	{
-		printf("Error creating renderer. SDL_Error: %s\n", SDL_GetError());
-		return 1;
+		roms.push_back(file_path);
 	}
+	file_path = roms[0];
 
-    // Create texture that stores frame buffer
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+	//Wall mode runs its own sessions and window
+	if(wall_count > 0)
+	{
+		if(headless || terminal || capture_path != NULL || gdb_port != 0)
+		{
+			printf("--wall cannot be combined with --headless, --term, --capture or --gdb\n");
+			return 1;
+		}
 
+#ifdef CHIP8_SDL
+		int result = 1;
+		{
+			WallDisplay wall;
+			if(wall.load(wall_count, roms))
+			{
+				result = wall.run(max_cycles);
+			}
+			else
+			{
+				printf("Could not load ROM\n");
+			}
+		}
+		SDL_Quit();
+		return result;
+#else
+		printf("--wall needs SDL2, which this build was made without\n");
+		return 1;
+#endif
+	}
 
-	//Sticking with just loading PONG as a way to show off emulator.
-	const char *file_path = "roms/PONG";	
-	
 	//Load ROM:
 	if(!chip8.load(file_path))
 	{
 		printf("Could not load ROM\n");
 		return 1;
 	}
-	//Temporary buffer of pixels 
-	uint32_t pixels[2048];
 
-	//Quit flag for main loop
-	bool quit = false;
+	FrameCapture capture;
+	GdbStub debugger(chip8);
 
-	//Emulation Loop:
- 	while (quit != true)
+	//The terminal front-end owns the screen, stray output would break its cursor
+	//tracking. A failed capture still shows in the summary printed on exit.
+	if(terminal)
 	{
-		//Start emulating cycle
-		chip8.emulateCycle();
+		chip8.messages = NULL;
+		capture.messages = NULL;
+		debugger.messages = NULL;
+	}
+
+	//Frame recorder, encodes on its own thread
+	if(capture_path != NULL && !capture.open(capture_path))
+	{
+		return 1;
+	}
+
+	//Debugger is only consulted when --gdb is given, so normal runs pay nothing for it
+	bool debugging = (gdb_port != 0);
+	if(debugging && !debugger.listen(gdb_port))
+	{
+		return 1;
+	}
 
-		SDL_Event event;
-		//Check for SDL events/ keypresses
-		while (SDL_PollEvent(&event))
+	//Pick the front-end. Headless runs have none.
+#ifdef CHIP8_SDL
+	SdlFrontend window;
+#endif
+	TerminalFrontend term;
+	Frontend *frontend = NULL;
+	if(terminal)
+	{
+		if(!term.init())
 		{
-			switch (event.type)
-			{
-				
-			//User requests to close the window
-			case SDL_QUIT:
-				quit = true;
-				break;
-
-			//User presses a key
-			case SDL_KEYDOWN:
-				//Escape key
-				if (event.key.keysym.sym == SDLK_ESCAPE)
-				{
-					quit = true;
-				}
-
-				//Check key pressed against keymap
-				for(int i = 0; i < 16; i++)
-				{
-					if(event.key.keysym.sym == keymap[i])
-					{
-						chip8.key[i] = 1;
-					}
-				}
-				break;
-
-			case SDL_KEYUP:
-				for(int i = 0; i < 16; i++)
-				{
-					if(event.key.keysym.sym == keymap[i])
-					{
-						chip8.key[i] = 0;
-					}
-				}
-				break;
-			}
+			return 1;
 		}
-
-		//If a draw occured, update display
-		if(chip8.draw_flag == true)
+		frontend = &term;
+	}
+	else if(!headless)
+	{
+#ifdef CHIP8_SDL
+		if(!window.init())
 		{
-			//reset draw_flag
-			chip8.draw_flag = false; 	
-
-			//Assign colors to pixels, in this case black and white
-			for(int i = 0; i < 2048; i++)
-			{
-				int pixel = chip8.gfx[i];
-				
-				if(pixel == 1)
-				{
-					pixels[i] = 0x00FFFFFF;
-				}
-				if(pixel == 0)
-				{
-					pixels[i] = 0xFF000000;
-				}
-	
-			}
-	
-
-			//Update texture to be displayed
-			SDL_UpdateTexture(texture, NULL, pixels, width * sizeof(int));
-           		//Clear screen
-			SDL_RenderClear(renderer);
-			//Render texture to screen
-			SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-			//Update screen
-			SDL_RenderPresent(renderer);
-
+			return 1;
 		}
-		//Set a small delay for each cycle to slow down emulation
-		SDL_Delay(2);
+		frontend = &window;
+#else
+		printf("No window support in this build (SDL2 was not found), use --term or --headless\n");
+		return 1;
+#endif
 	}
 
-	//Clear memory for SDL texture, renderer, and window
-	SDL_DestroyTexture(texture);
-	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
-	window = NULL;
-	renderer = NULL;
-	texture = NULL;
-
-	SDL_Quit();
+	//Emulation Loop:
+	runEmulation(chip8, frontend, capture, debugging ? &debugger : NULL, max_cycles);
 
+	//The capture flushes its remaining frames and reports drops when it goes out
+	//of scope, after the front-end has closed the window or restored the terminal.
 	return 0;
 }
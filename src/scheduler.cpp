@@ -0,0 +1,65 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: scheduler.cpp
+ * The emulation loop: run a cycle, read input, present any new frame and
+ * sleep a little. The SDL window, the terminal and headless runs all go
+ * through here so they behave the same.
+****************************************************************************/
+#include <chrono>
+#include <thread>
+
+#include "scheduler.h"
+
+void runEmulation(Chip8 &chip8, Frontend *frontend, FrameCapture &capture, GdbStub *debugger, long max_cycles)
+{
+    //Quit flag for main loop
+    bool quit = false;
+
+    while(quit != true)
+    {
+        //Stop here if the debugger wants to, or quit if it killed the program
+        if(debugger != NULL && !debugger->beforeCycle())
+        {
+            break;
+        }
+
+        //Start emulating cycle
+        chip8.emulateCycle();
+
+        if(debugger != NULL)
+        {
+            debugger->afterCycle();
+        }
+
+        if(max_cycles > 0 && --max_cycles == 0)
+        {
+            quit = true;
+        }
+
+        //Check for keypresses
+        if(frontend != NULL && !frontend->pollInput(chip8.key))
+        {
+            quit = true;
+        }
+
+        //If a draw occured, update display
+        if(chip8.draw_flag == true)
+        {
+            //reset draw_flag
+            chip8.draw_flag = false;
+
+            //Hand the frame to the recorder. Never blocks.
+            capture.submit(chip8.gfx);
+
+            if(frontend != NULL)
+            {
+                frontend->present(chip8.gfx);
+            }
+        }
+
+        //Set a small delay for each cycle to slow down emulation
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
@@ -0,0 +1,19 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: scheduler.h
+ * Emulation loop shared by every front-end.
+****************************************************************************/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include "chip8.h"
+#include "frontend.h"
+#include "capture.h"
+#include "gdbstub.h"
+
+//Runs until the front-end quits, the debugger kills the program, or max_cycles
+//have run (0 or less for no limit). frontend and debugger may be NULL.
+void runEmulation(Chip8 &chip8, Frontend *frontend, FrameCapture &capture, GdbStub *debugger, long max_cycles);
+
+#endif /* SCHEDULER_H  */
@@ -0,0 +1,137 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: sdl_frontend.cpp
+ * Shows the chip-8 screen in an SDL window and reads the keyboard.
+ * To learn the basics of SDL, I used the tutorial guides from LazyFoo.com
+ * https://lazyfoo.net/tutorials/SDL/index.php#Key%20Presses
+****************************************************************************/
+#include <stdio.h>
+
+#include "sdl_frontend.h"
+
+//Screen size
+static const int width = 64;
+static const int height = 32;
+
+//keymap representing 16 keys from 1-v
+static const uint8_t keymap[16] = {
+    SDLK_1, SDLK_2, SDLK_3,
+    SDLK_q, SDLK_w, SDLK_e,
+    SDLK_a, SDLK_s, SDLK_d,
+    SDLK_z, SDLK_x, SDLK_c,
+    SDLK_4, SDLK_r, SDLK_f,
+    SDLK_v,
+};
+
+SdlFrontend::SdlFrontend()
+    : window(NULL), renderer(NULL), texture(NULL)
+{
+
+}
+SdlFrontend::~SdlFrontend()
+{
+    //Clear memory for SDL texture, renderer, and window
+    if(texture != NULL)
+        SDL_DestroyTexture(texture);
+    if(renderer != NULL)
+        SDL_DestroyRenderer(renderer);
+    if(window != NULL)
+        SDL_DestroyWindow(window);
+    window = NULL;
+    renderer = NULL;
+    texture = NULL;
+
+    SDL_Quit();
+}
+
+bool SdlFrontend::init()
+{
+    //Create window. I wanted it bigger, so it is scaled up by 15
+    window = SDL_CreateWindow("CHIP-8 Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width *15, height*15, SDL_WINDOW_SHOWN);
+    if (window == NULL){
+        printf( "Error creating SDL window. SDL_Error: %s\n", SDL_GetError() );
+        return false;
+    }
+
+    //Create renderer for window
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    if(renderer == NULL)
+    {
+        printf("Error creating renderer. SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_RenderSetLogicalSize(renderer, width, height);
+
+    // Create texture that stores frame buffer
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+    return true;
+}
+
+//Check for SDL events/ keypresses
+bool SdlFrontend::pollInput(unsigned char *key)
+{
+    bool quit = false;
+
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+
+        //User requests to close the window
+        case SDL_QUIT:
+            quit = true;
+            break;
+
+        //User presses a key
+        case SDL_KEYDOWN:
+            //Escape key
+            if (event.key.keysym.sym == SDLK_ESCAPE)
+            {
+                quit = true;
+            }
+
+            //Check key pressed against keymap
+            for(int i = 0; i < 16; i++)
+            {
+                if(event.key.keysym.sym == keymap[i])
+                {
+                    key[i] = 1;
+                }
+            }
+            break;
+
+        case SDL_KEYUP:
+            for(int i = 0; i < 16; i++)
+            {
+                if(event.key.keysym.sym == keymap[i])
+                {
+                    key[i] = 0;
+                }
+            }
+            break;
+        }
+    }
+
+    return !quit;
+}
+
+void SdlFrontend::present(const unsigned char *gfx)
+{
+    //Assign colors to pixels, in this case black and white
+    for(int i = 0; i < 2048; i++)
+    {
+        pixels[i] = (gfx[i] == 1) ? 0x00FFFFFF : 0xFF000000;
+    }
+
+    //Update texture to be displayed
+    SDL_UpdateTexture(texture, NULL, pixels, width * sizeof(uint32_t));
+    //Clear screen
+    SDL_RenderClear(renderer);
+    //Render texture to screen
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    //Update screen
+    SDL_RenderPresent(renderer);
+}
@@ -0,0 +1,36 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: sdl_frontend.h
+ * Header file for the SDL window front-end.
+****************************************************************************/
+#ifndef SDL_FRONTEND_H
+#define SDL_FRONTEND_H
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include "frontend.h"
+
+class SdlFrontend : public Frontend {
+    private:
+
+        //SDL window, renderer, and texture
+        SDL_Window *window;
+        SDL_Renderer *renderer;
+        SDL_Texture *texture;
+
+        uint32_t pixels[2048];              //Temporary buffer of pixels
+
+
+    public:
+
+        SdlFrontend();
+        ~SdlFrontend();
+
+        bool init();                        //Opens the window.
+
+        bool pollInput(unsigned char * key);
+        void present(const unsigned char * gfx);
+};
+
+#endif /* SDL_FRONTEND_H  */
@@ -0,0 +1,273 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: term.cpp
+ * Draws the chip-8 screen in a terminal with Unicode half blocks, two
+ * pixels per character, so 64x32 pixels fit in 64x16 cells. Only cells
+ * that changed since the last frame are rewritten, which keeps the
+ * traffic over ssh small. Keys are read from stdin in raw mode.
+****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "term.h"
+
+//Cell glyphs indexed by (bottom pixel << 1) | top pixel
+static const char *glyphs[4] = { " ", "▀", "▄", "█" };
+
+//Same layout as the SDL keymap, keys 1-v
+static const char keymap[16] = {
+    '1', '2', '3',
+    'q', 'w', 'e',
+    'a', 's', 'd',
+    'z', 'x', 'c',
+    '4', 'r', 'f',
+    'v',
+};
+
+//Terminals have no key up events, so a key counts as released once it has
+//not been seen for a while. Autorepeat starts 250-600ms after the first press,
+//then repeats every 30-50ms, so the first timeout has to outlast the delay.
+static const std::chrono::milliseconds key_first_hold(600);
+static const std::chrono::milliseconds key_repeat_hold(100);
+
+//A lone escape byte is only taken as the Escape key once this long has
+//passed without the rest of a sequence arriving.
+static const std::chrono::milliseconds escape_timeout(50);
+
+//Writes to the terminal are capped at about 60 frames per second.
+static const std::chrono::milliseconds frame_interval(16);
+
+TerminalFrontend::TerminalFrontend()
+    : raw(false), dirty(false), input_state(INPUT_TEXT), cursor_row(-1), cursor_col(-1)
+{
+    memset(shown, 0xFF, sizeof(shown));     //Nothing valid on screen yet, forces a full draw.
+    memset(pending, 0, sizeof(pending));
+}
+TerminalFrontend::~TerminalFrontend()
+{
+    if(raw)
+    {
+        //Park the cursor under the screen, show it again and restore the terminal
+        char reset[32];
+        int size = snprintf(reset, sizeof(reset), "\x1b[%d;1H\x1b[?25h", ROWS + 1);
+        writeOut(reset, size);
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+    }
+}
+
+bool TerminalFrontend::init()
+{
+    if(tcgetattr(STDIN_FILENO, &saved_termios) < 0)
+    {
+        printf("Terminal mode needs stdin to be a terminal.\n");
+        return false;
+    }
+
+    //No line buffering, echo or signals; reads return straight away.
+    struct termios settings = saved_termios;
+    settings.c_lflag &= ~(ICANON | ECHO | ISIG);
+    settings.c_cc[VMIN] = 0;
+    settings.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &settings);
+    raw = true;
+
+    //Hide the cursor and clear the screen
+    fflush(stdout);
+    writeOut("\x1b[?25l\x1b[2J", 10);
+    last_flush = Clock::now() - frame_interval;
+    return true;
+}
+
+bool TerminalFrontend::pollInput(unsigned char *key)
+{
+    bool quit = false;
+    Clock::time_point now = Clock::now();
+
+    unsigned char input[64];
+    ssize_t count = read(STDIN_FILENO, input, sizeof(input));
+    for(ssize_t i = 0; i < count; i++)
+    {
+        unsigned char c = input[i];
+
+        //Escape sequences such as arrow keys can be split over reads, so the
+        //parser state carries over from one call to the next.
+        if(input_state == INPUT_ESCAPE)
+        {
+            //ESC [ starts a CSI sequence, ESC O an SS3 one, anything else was Alt+key
+            input_state = (c == '[') ? INPUT_CSI : (c == 'O') ? INPUT_SS3 : INPUT_TEXT;
+            continue;
+        }
+        if(input_state == INPUT_CSI)
+        {
+            //Parameter bytes run until a final byte in 0x40-0x7E
+            if(c >= 0x40 && c <= 0x7E)
+            {
+                input_state = INPUT_TEXT;
+            }
+            continue;
+        }
+        if(input_state == INPUT_SS3)
+        {
+            input_state = INPUT_TEXT;
+            continue;
+        }
+
+        if(c == 0x03)
+        {
+            quit = true;
+            break;
+        }
+        if(c == 0x1b)
+        {
+            input_state = INPUT_ESCAPE;
+            escape_time = now;
+            continue;
+        }
+
+        for(int k = 0; k < 16; k++)
+        {
+            if(tolower(c) == keymap[k])
+            {
+                //Already held means this is an autorepeat
+                key_release[k] = now + (key[k] ? key_repeat_hold : key_first_hold);
+                key[k] = 1;
+            }
+        }
+    }
+
+    //An escape with nothing after it is the Escape key, which quits
+    if(input_state == INPUT_ESCAPE && now - escape_time >= escape_timeout)
+    {
+        quit = true;
+    }
+
+    for(int k = 0; k < 16; k++)
+    {
+        if(key[k] != 0 && now >= key_release[k])
+        {
+            key[k] = 0;
+        }
+    }
+
+    //Write out a frame that was held back by the frame cap
+    if(dirty && now - last_flush >= frame_interval)
+    {
+        flush();
+    }
+
+    return !quit;
+}
+
+void TerminalFrontend::present(const unsigned char *gfx)
+{
+    for(int row = 0; row < ROWS; row++)
+    {
+        const unsigned char *top = gfx + (row * 2) * 64;
+        const unsigned char *bottom = top + 64;
+        for(int col = 0; col < COLUMNS; col++)
+        {
+            pending[row][col] = (top[col] & 1) | ((bottom[col] & 1) << 1);
+        }
+    }
+    dirty = true;
+
+    if(Clock::now() - last_flush >= frame_interval)
+    {
+        flush();
+    }
+}
+
+//Writes every cell that differs from what is on screen.
+void TerminalFrontend::flush()
+{
+    out.clear();
+
+    //Something else may have written to the terminal since the last flush,
+    //so start from an absolute cursor position instead of the tracked one.
+    cursor_row = -1;
+    cursor_col = -1;
+
+    for(int row = 0; row < ROWS; row++)
+    {
+        for(int col = 0; col < COLUMNS; col++)
+        {
+            if(pending[row][col] == shown[row][col])
+            {
+                continue;
+            }
+            moveTo(row, col);
+            out += glyphs[pending[row][col]];
+            shown[row][col] = pending[row][col];
+            cursor_col++;
+        }
+    }
+
+    if(!out.empty())
+    {
+        writeOut(out.data(), out.size());
+    }
+    dirty = false;
+    last_flush = Clock::now();
+}
+
+//Moves the cursor using whichever sequence is shortest.
+void TerminalFrontend::moveTo(int row, int col)
+{
+    if(row == cursor_row && col == cursor_col)
+    {
+        return;
+    }
+
+    char sequence[16];
+    int size;
+
+    if(row == cursor_row && col > cursor_col)
+    {
+        //Rewriting the unchanged cells in between can be shorter than a cursor move
+        size_t rewrite = 0;
+        for(int c = cursor_col; c < col; c++)
+        {
+            rewrite += strlen(glyphs[shown[row][c]]);
+        }
+        size = snprintf(sequence, sizeof(sequence), "\x1b[%dC", col - cursor_col);
+        if(rewrite <= (size_t)size)
+        {
+            for(int c = cursor_col; c < col; c++)
+            {
+                out += glyphs[shown[row][c]];
+            }
+            cursor_col = col;
+            return;
+        }
+    }
+    else if(cursor_row >= 0 && row == cursor_row + 1 && col == 0)
+    {
+        size = snprintf(sequence, sizeof(sequence), "\r\n");
+    }
+    else
+    {
+        size = snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", row + 1, col + 1);
+    }
+
+    out.append(sequence, size);
+    cursor_row = row;
+    cursor_col = col;
+}
+
+void TerminalFrontend::writeOut(const char *data, size_t size)
+{
+    while(size > 0)
+    {
+        ssize_t written = write(STDOUT_FILENO, data, size);
+        if(written <= 0)
+        {
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: term.h
+ * Header file for the terminal front-end, for machines without a display.
+****************************************************************************/
+#ifndef TERM_H
+#define TERM_H
+#include <termios.h>
+#include <chrono>
+#include <string>
+#include "frontend.h"
+
+class TerminalFrontend : public Frontend {
+    private:
+
+        typedef std::chrono::steady_clock Clock;
+
+        static const int COLUMNS = 64;
+        static const int ROWS = 16;                 //Each character cell holds two pixels, one above the other.
+
+        struct termios saved_termios;
+        bool raw;
+
+        unsigned char shown[ROWS][COLUMNS];         //Cell contents currently on the terminal.
+        unsigned char pending[ROWS][COLUMNS];       //Latest frame, not yet written.
+        bool dirty;
+        Clock::time_point last_flush;
+
+        Clock::time_point key_release[16];          //Terminals have no key up events, so keys time out.
+
+        //Where the input parser is inside an escape sequence
+        enum InputState { INPUT_TEXT, INPUT_ESCAPE, INPUT_CSI, INPUT_SS3 };
+        InputState input_state;
+        Clock::time_point escape_time;              //When the last lone escape byte arrived.
+
+        std::string out;                            //Escape sequences for one flush, written with one call.
+        int cursor_row;
+        int cursor_col;
+
+        void flush();
+        void moveTo(int row, int col);
+        void writeOut(const char * data, size_t size);
+
+
+    public:
+
+        TerminalFrontend();
+        ~TerminalFrontend();
+
+        bool init();                                //Switches stdin to raw mode and clears the screen.
+
+        bool pollInput(unsigned char * key);
+        void present(const unsigned char * gfx);
+};
+
+#endif /* TERM_H  */
@@ -0,0 +1,231 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: wall.cpp
+ * Runs many chip-8 instances on worker threads and shows them all in one
+ * window. Every instance owns a 64x32 tile of a single streaming texture;
+ * only tiles that changed are uploaded, and the whole wall is drawn with
+ * one SDL_RenderCopy per frame.
+****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "wall.h"
+
+WallDisplay::WallDisplay()
+    : count(0), columns(0), rows(0), instances(NULL), tiles(NULL), running(false), finished_workers(0),
+      window(NULL), renderer(NULL), atlas(NULL)
+{
+
+}
+WallDisplay::~WallDisplay()
+{
+    running = false;
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    if(atlas != NULL)
+        SDL_DestroyTexture(atlas);
+    if(renderer != NULL)
+        SDL_DestroyRenderer(renderer);
+    if(window != NULL)
+        SDL_DestroyWindow(window);
+
+    delete[] instances;
+    delete[] tiles;
+}
+
+//Loads a ROM into every instance and works out the tile layout.
+bool WallDisplay::load(int n, const std::vector<const char *> &roms)
+{
+    if(n <= 0 || roms.empty())
+    {
+        return false;
+    }
+
+    count = n;
+    columns = (int)ceil(sqrt((double)count));
+    rows = (count + columns - 1) / columns;
+
+    instances = new Chip8[count];
+    tiles = new Tile[count];
+
+    for(int i = 0; i < count; i++)
+    {
+        if(!instances[i].load(roms[i % roms.size()]))
+        {
+            return false;
+        }
+        memset(tiles[i].gfx, 0, sizeof(tiles[i].gfx));
+        tiles[i].dirty = true;
+    }
+    return true;
+}
+
+bool WallDisplay::createWindow()
+{
+    int width = columns * 64;
+    int height = rows * 32;
+
+    //Scale the wall up to roughly the size of the single instance window
+    int scale = 960 / width;
+    if(scale < 1)
+    {
+        scale = 1;
+    }
+
+    if(SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        printf("Error initializing SDL. SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    window = SDL_CreateWindow("CHIP-8 Wall", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width * scale, height * scale, SDL_WINDOW_SHOWN);
+    if(window == NULL)
+    {
+        printf("Error creating SDL window. SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    if(renderer == NULL)
+    {
+        printf("Error creating renderer. SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_RenderSetLogicalSize(renderer, width, height);
+
+    atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if(atlas == NULL)
+    {
+        printf("Error creating texture. SDL_Error: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+//Worker thread. Paced like the single instance loop: one cycle per instance every 2ms.
+//Stops after max_cycles cycles per instance, or never if max_cycles is 0 or less,
+//the same as the single instance loop.
+void WallDisplay::work(int first, int step, long max_cycles)
+{
+    for(long cycle = 0; running && (max_cycles <= 0 || cycle < max_cycles); cycle++)
+    {
+        for(int i = first; i < count; i += step)
+        {
+            Chip8 &chip8 = instances[i];
+            chip8.emulateCycle();
+
+            //Publish the frame for the render thread
+            if(chip8.draw_flag == true)
+            {
+                chip8.draw_flag = false;
+                std::lock_guard<std::mutex> guard(tiles[i].lock);
+                memcpy(tiles[i].gfx, chip8.gfx, sizeof(tiles[i].gfx));
+                tiles[i].dirty = true;
+            }
+        }
+        SDL_Delay(2);
+    }
+    ++finished_workers;
+}
+
+//Copies every tile that changed since the last frame into the atlas.
+void WallDisplay::uploadDirtyTiles()
+{
+    uint32_t pixels[64 * 32];
+
+    for(int i = 0; i < count; i++)
+    {
+        Tile &tile = tiles[i];
+        if(!tile.dirty)
+        {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(tile.lock);
+            for(int p = 0; p < 64 * 32; p++)
+            {
+                pixels[p] = tile.gfx[p] ? 0x00FFFFFF : 0xFF000000;
+            }
+            tile.dirty = false;
+        }
+
+        SDL_Rect rect = { (i % columns) * 64, (i / columns) * 32, 64, 32 };
+        SDL_UpdateTexture(atlas, &rect, pixels, 64 * sizeof(uint32_t));
+    }
+}
+
+int WallDisplay::run(long max_cycles)
+{
+    if(count == 0 || !createWindow())
+    {
+        return 1;
+    }
+
+    //Split the instances over the available cores
+    int threads = (int)std::thread::hardware_concurrency();
+    if(threads < 1)
+    {
+        threads = 1;
+    }
+    if(threads > count)
+    {
+        threads = count;
+    }
+
+    running = true;
+    finished_workers = 0;
+    for(int t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread(&WallDisplay::work, this, t, threads, max_cycles));
+    }
+
+    bool quit = false;
+    while(quit != true)
+    {
+        uint32_t frame_start = SDL_GetTicks();
+
+        SDL_Event event;
+        while(SDL_PollEvent(&event))
+        {
+            if(event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+            {
+                quit = true;
+            }
+        }
+
+        //Every session has run its cycles
+        if(finished_workers == (int)workers.size())
+        {
+            quit = true;
+        }
+
+        uploadDirtyTiles();
+
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, atlas, nullptr, nullptr);
+        SDL_RenderPresent(renderer);
+
+        //Cap at 60 Hz, the wall does not need more
+        uint32_t elapsed = SDL_GetTicks() - frame_start;
+        if(elapsed < 16)
+        {
+            SDL_Delay(16 - elapsed);
+        }
+    }
+
+    running = false;
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: wall.h
+ * Header file for the wall display, which shows many chip-8 sessions in
+ * one window.
+****************************************************************************/
+#ifndef WALL_H
+#define WALL_H
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "chip8.h"
+
+class WallDisplay {
+    private:
+
+        //Latest frame published by one instance.
+        struct Tile {
+            std::mutex lock;
+            unsigned char gfx[64 * 32];
+            std::atomic<bool> dirty;
+        };
+
+        int count;
+        int columns;
+        int rows;
+
+        Chip8 *instances;
+        Tile *tiles;
+
+        std::vector<std::thread> workers;
+        std::atomic<bool> running;
+        std::atomic<int> finished_workers;
+
+        SDL_Window *window;
+        SDL_Renderer *renderer;
+        SDL_Texture *atlas;                     //All framebuffers packed into one streaming texture.
+
+        void work(int first, int step, long max_cycles);  //Runs every step'th instance starting at first.
+        bool createWindow();
+        void uploadDirtyTiles();
+
+
+    public:
+
+        WallDisplay();
+        ~WallDisplay();
+
+        bool load(int count, const std::vector<const char *> &roms);   //Instance i runs roms[i % roms.size()]
+        int run(long max_cycles);               //Shows the wall until the window is closed or every
+                                                //session has run max_cycles cycles (0 or less for no limit).
+};
+
+#endif /* WALL_H  */
@@ -0,0 +1,221 @@
+/****************************************************************************
+ * Program: Chip-8 Emulator
+ * Author: Peter Dorich
+
+ * File: c8rl.cpp
+ * Reader for the capture stream written by --capture (layout in
+ * src/capture.h). Checks every record, reports dropped frames and can
+ * dump the decoded frames as PGM images.
+ *
+ * Usage: c8rl FILE [--pgm PREFIX]
+ *
+ * FILE may be "-" to read a stream from stdin, e.g.
+ *     gunzip -c run.c8rl.gz | c8rl - --pgm frames/run
+ * writes frames/run-000000.pgm, frames/run-000001.pgm, ... Exits non-zero
+ * if the stream is malformed.
+****************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+static const int WIDTH = 64;
+static const int HEIGHT = 32;
+static const int FRAME_SIZE = WIDTH * HEIGHT;
+
+static bool readBytes(FILE *in, unsigned char *data, size_t size)
+{
+    return fread(data, 1, size, in) == size;
+}
+
+//Writes one frame as a binary PGM, lit pixels white.
+static bool writePgm(const char *prefix, uint32_t number, const unsigned char *frame)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s-%06u.pgm", prefix, (unsigned)number);
+
+    FILE *file = fopen(path, "wb");
+    if(file == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    unsigned char pixels[FRAME_SIZE];
+    for(int i = 0; i < FRAME_SIZE; i++)
+    {
+        pixels[i] = frame[i] ? 255 : 0;
+    }
+
+    fprintf(file, "P5\n%d %d\n255\n", WIDTH, HEIGHT);
+    bool ok = fwrite(pixels, 1, sizeof(pixels), file) == sizeof(pixels);
+    if(fclose(file) != 0 || !ok)
+    {
+        fprintf(stderr, "Could not write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    const char *pgm_prefix = NULL;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--pgm") == 0 && i + 1 < argc)
+        {
+            pgm_prefix = argv[++i];
+        }
+        else if(path == NULL)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path = NULL;
+            break;
+        }
+    }
+    if(path == NULL)
+    {
+        fprintf(stderr, "Usage: %s FILE [--pgm PREFIX]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if(in == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+
+    unsigned char header[8];
+    if(!readBytes(in, header, sizeof(header)) || memcmp(header, "C8RL", 4) != 0)
+    {
+        fprintf(stderr, "%s: not a capture stream\n", path);
+        return 1;
+    }
+    if(header[4] != 1 || header[5] != WIDTH || header[6] != HEIGHT)
+    {
+        fprintf(stderr, "%s: unsupported stream (version %d, %dx%d)\n", path, header[4], header[5], header[6]);
+        return 1;
+    }
+
+    unsigned char frame[FRAME_SIZE];
+    unsigned char payload[0x10000];
+    memset(frame, 0, sizeof(frame));
+
+    unsigned long records = 0;
+    unsigned long missing = 0;
+    unsigned long gaps = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    const char *error = NULL;
+
+    unsigned char record[7];
+    size_t got;
+    while((got = fread(record, 1, sizeof(record), in)) > 0)
+    {
+        if(got != sizeof(record))
+        {
+            error = "truncated record";
+            break;
+        }
+
+        uint32_t number = record[0] | record[1] << 8 | record[2] << 16 | (uint32_t)record[3] << 24;
+        int type = record[4];
+        int size = record[5] | record[6] << 8;
+
+        if(type > 1)
+        {
+            error = "unknown record type";
+        }
+        else if(records == 0 && type != 0)
+        {
+            error = "stream does not start with a key frame";
+        }
+        else if(records > 0 && number <= last)
+        {
+            error = "frame numbers go backwards";
+        }
+        else if(size % 2 != 0 || !readBytes(in, payload, size))
+        {
+            error = "truncated record";
+        }
+        if(error != NULL)
+        {
+            break;
+        }
+
+        //Expand the (count, value) runs, XORed onto the previous frame for deltas
+        int pixel = 0;
+        for(int p = 0; p < size; p += 2)
+        {
+            int count = payload[p];
+            if(count == 0 || pixel + count > FRAME_SIZE)
+            {
+                error = "bad run length";
+                break;
+            }
+            for(int c = 0; c < count; c++, pixel++)
+            {
+                frame[pixel] = (type == 0) ? payload[p + 1] : (frame[pixel] ^ payload[p + 1]);
+            }
+        }
+        if(error == NULL && pixel != FRAME_SIZE)
+        {
+            error = "record does not cover the whole frame";
+        }
+        if(error != NULL)
+        {
+            break;
+        }
+
+        //Gaps in the numbering are frames the recorder dropped
+        if(records == 0)
+        {
+            first = number;
+        }
+        else if(number != last + 1)
+        {
+            gaps++;
+            missing += number - last - 1;
+        }
+        last = number;
+        records++;
+
+        if(pgm_prefix != NULL && !writePgm(pgm_prefix, number, frame))
+        {
+            return 1;
+        }
+    }
+
+    if(error == NULL && ferror(in))
+    {
+        error = "read error";
+    }
+    if(in != stdin)
+    {
+        fclose(in);
+    }
+
+    //Frames dropped before the first record or after the last cannot be seen here.
+    //A stream cut off part way still reports what was read before the error.
+    if(records == 0)
+    {
+        printf("%s: no frames\n", path);
+    }
+    else
+    {
+        printf("%s: %lu frames (%u-%u), %lu missing in %lu gaps\n",
+               path, records, (unsigned)first, (unsigned)last, missing, gaps);
+    }
+
+    if(error != NULL)
+    {
+        fprintf(stderr, "%s: record %lu: %s\n", path, records, error);
+        return 1;
+    }
+    return 0;
+}